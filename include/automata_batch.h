@@ -0,0 +1,29 @@
+/*
+ ============================================================================
+ Name        : automata_batch.h
+ Author      : Eduardo Lopes
+ Version     :
+ Copyright   : MIT license
+ Description : FTC task
+ ============================================================================
+ */
+
+#ifndef AUTOMATA_BATCH_H_
+#define AUTOMATA_BATCH_H_
+
+#include "automata_convert.h"
+
+/**
+ * Test several sentences on deterministic automata. Sentences are sorted,
+ * so the prefix shared with the previous one is walked only once
+ *
+ * @automata: Pointer to deterministic automata struct
+ * @sentences: Sentences to automata test
+ * @count: Total of sentences
+ * @accepted: Receives the result of each sentence, on the given order
+ * @return: Total of transitions walked
+ */
+size_t simulate_batch(af_t *automata, char **sentences, size_t count,
+                      short *accepted);
+
+#endif /* AUTOMATA_BATCH_H_ */
@@ -0,0 +1,72 @@
+/*
+ ============================================================================
+ Name        : automata_cache.h
+ Author      : Eduardo Lopes
+ Version     :
+ Copyright   : MIT license
+ Description : FTC task
+ ============================================================================
+ */
+
+#ifndef AUTOMATA_CACHE_H_
+#define AUTOMATA_CACHE_H_
+
+#include "automata_convert.h"
+
+#define CACHE_MAGIC "AFDC"
+#define CACHE_VERSION 1
+#define CACHE_KEY_SIZE 32 // SHA-256
+#define CACHE_MAX_SIZE (64UL * 1024 * 1024)
+#define CACHE_TMP_TIMEOUT 3600 // Seconds before a temporary file is stale
+
+/**
+ * Directory with the deterministic automata already converted, one file
+ * for each key. The least recently used files are removed when the
+ * directory is bigger than max_size
+ */
+typedef struct af_cache {
+  char *dir;
+  size_t max_size;
+} af_cache_t;
+
+/**
+ * Compute the key of a conversion, the SHA-256 of the normalized non
+ * deterministic automata (states, start, finals and transitions) and of
+ * the conversion options
+ *
+ * @automata: Pointer to non deterministic automata struct
+ * @options: Description of the conversion options
+ * @key: Buffer with CACHE_KEY_SIZE positions
+ */
+void cache_key(af_t *automata, char *options, unsigned char *key);
+
+/**
+ * Load the deterministic automata saved with given key
+ *
+ * @cache: Pointer to cache struct
+ * @key: Key computed by cache_key
+ * @automata: Pointer to automata struct to fill
+ * @return: 1 if the entry exists and is valid, else 0
+ */
+short cache_load(af_cache_t *cache, unsigned char *key, af_t *automata);
+
+/**
+ * Save the deterministic automata with given key, and evict old entries
+ *
+ * @cache: Pointer to cache struct
+ * @key: Key computed by cache_key
+ * @automata: Pointer to deterministic automata struct
+ * @return: 1 if the entry was written, else 0
+ */
+short cache_store(af_cache_t *cache, unsigned char *key, af_t *automata);
+
+/**
+ * Remove the least recently used entries until the cache fits in its
+ * max size. Temporary files of writers that died before the rename are
+ * removed once they are older than CACHE_TMP_TIMEOUT
+ *
+ * @cache: Pointer to cache struct
+ */
+void cache_evict(af_cache_t *cache);
+
+#endif /* AUTOMATA_CACHE_H_ */
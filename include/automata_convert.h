@@ -42,6 +42,7 @@ typedef struct af {
   size_t num_transition;
   char *alphabet;
   size_t alphabet_size;
+  short dead; // State that never reaches a final one, -1 if there is none
 } af_t;
 
 /**
@@ -66,6 +67,23 @@ void show_automata(af_t *automata);
  */
 void automata_file_parser(char *stream, af_t *automata);
 
+/**
+ * Read a file with one sentence per line
+ *
+ * @stream: Path of sentences file
+ * @count: Total of sentences read
+ * @return: Array of sentences, or NULL if file can't be opened
+ */
+char **read_sentences(char *stream, size_t *count);
+
+/**
+ * Free memory of sentences array
+ *
+ * @sentences: Array returned by read_sentences
+ * @count: Total of sentences
+ */
+void free_sentences(char **sentences, size_t count);
+
 /**
  * Initialize each attribute of automata with 0 (or NULL). Do it is a easily way
  * to initialize counters and pointers
@@ -83,13 +101,25 @@ void init_automata(af_t *automata);
 void get_states(FILE *file, af_t *automata);
 
 /**
- * Parse the .jff file to get transitions of non deterministic automata
+ * Parse the .jff file to get transitions of non deterministic automata.
+ * Labels with more than one byte, like strings, UTF-8 symbols and code
+ * point ranges ([a-z]), become a chain of byte transitions
  *
  * @file: Pointer to .jff file to read
  * @automata: Pointer to automata struct
  */
 void get_transitions(FILE *file, af_t *automata);
 
+/**
+ * Append a transition to the automata arrays
+ *
+ * @automata: Pointer to automata struct
+ * @from: Origin state
+ * @to: Target state
+ * @symbol: Symbol read by the transition
+ */
+void append_transition(af_t *automata, short from, short to, char symbol);
+
 /**
  * Get the symbols used in automata diagram
  *
@@ -159,7 +189,16 @@ short is_non_deterministic_transaction(transition_t *new_automata,
 short simulate_automata(af_t *automata, char *sentence);
 
 /**
- * Return the next reachable state with given symbol
+ * Test if the automata can't accept anymore from this state
+ *
+ * @automata: Pointer to automata struct
+ * @state: Actual state on automata, -1 if there was no transition
+ */
+short is_dead_state(af_t *automata, short state);
+
+/**
+ * Return the next reachable state with given symbol, or -1 if there is
+ * no transition
  *
  * @state: List of transitions
  * @symbol: List of transitions symbols
@@ -170,6 +209,15 @@ short simulate_automata(af_t *automata, char *sentence);
 short get_next_state(short **state, char *symbols, size_t size, int index,
                      char symbol);
 
+/**
+ * Total of state ids used by automata, including the states created
+ * by conversion that are referenced only by transitions
+ *
+ * @automata: Pointer to automata struct
+ * @return: Greatest state id plus one
+ */
+size_t count_states(af_t *automata);
+
 /**
  * Test if state are in final set
  *
@@ -179,7 +227,10 @@ short get_next_state(short **state, char *symbols, size_t size, int index,
 short is_final_state(short state, short *end);
 
 /**
- * Create a .jff file contain the description of given automata
+ * Create a .jff file contain the description of given automata. Each
+ * transition reads one byte, so a file with bytes above 0x7F is saved
+ * as ISO-8859-1 (one character for each byte of the UTF-8 labels).
+ * Control bytes are written as references like &#9;
  *
  * @automata: Pointer to automata struct
  */
@@ -0,0 +1,35 @@
+/*
+ ============================================================================
+ Name        : automata_renumber.h
+ Author      : Eduardo Lopes
+ Version     :
+ Copyright   : MIT license
+ Description : FTC task
+ ============================================================================
+ */
+
+#ifndef AUTOMATA_RENUMBER_H_
+#define AUTOMATA_RENUMBER_H_
+
+#include "automata_convert.h"
+
+/**
+ * Simulate a sentence and count how many times each state was visited
+ *
+ * @automata: Pointer to deterministic automata struct
+ * @sentence: Sentence of the sample workload
+ * @visits: Counters with count_states(automata) positions
+ */
+void profile_automata(af_t *automata, char *sentence, size_t *visits);
+
+/**
+ * Give new ids to the states so the hot ones are packed together at
+ * the beginning, and sort the transitions by origin state. Without
+ * visit counters, states are numbered in BFS order from the start
+ *
+ * @automata: Pointer to automata struct
+ * @visits: Counters filled by profile_automata, or NULL to use BFS order
+ */
+void renumber_states(af_t *automata, size_t *visits);
+
+#endif /* AUTOMATA_RENUMBER_H_ */
@@ -0,0 +1,94 @@
+/*
+ ============================================================================
+ Name        : automata_table.h
+ Author      : Eduardo Lopes
+ Version     :
+ Copyright   : MIT license
+ Description : FTC task
+ ============================================================================
+ */
+
+#ifndef AUTOMATA_TABLE_H_
+#define AUTOMATA_TABLE_H_
+
+#include <limits.h>
+#include <stdint.h>
+
+#include "automata_convert.h"
+
+#define COMB_TABLE_MAGIC "AFCT"
+#define COMB_TABLE_VERSION 3
+#define COMB_TABLE_HEADER_SIZE 536 // Magic, sizes, start, dead and classes
+
+/**
+ * Transition table compressed with row displacement (comb vector).
+ * Each state keeps only the transitions that differ of its default
+ * target, packed on next/check at the offset base[state]
+ */
+typedef struct comb_table {
+  short start;
+  short dead;         // Simulation stops on it, -1 if there is none
+  size_t num_states;
+  size_t num_classes;
+  short classes[256]; // Byte to symbol class, -1 if not in alphabet
+  int32_t *base;      // Offset of each state row on next/check
+  short *deflt;       // Target of each state when the slot isn't its own
+  short *next;        // Packed targets, -1 if there is no transition
+  short *check;       // State that owns each slot, -1 if free
+  size_t size;        // Total of slots on next/check
+  char *final;        // 1 if state is final
+} comb_table_t;
+
+/**
+ * Build the compressed table of a deterministic automata
+ *
+ * @automata: Pointer to deterministic automata struct
+ * @table: Pointer to table struct to fill
+ */
+void build_comb_table(af_t *automata, comb_table_t *table);
+
+/**
+ * Return the next state with given symbol on compressed table
+ *
+ * @table: Pointer to table struct
+ * @state: Actual state
+ * @symbol: Symbol to parse and get next state
+ * @return: Next state, or -1 if there is no transition
+ */
+short comb_next_state(comb_table_t *table, short state, char symbol);
+
+/**
+ * Test a given sentence on compressed table
+ *
+ * @table: Pointer to table struct
+ * @sentence: Sentence to automata test
+ * @return: 1 if sentence was accept, else 0
+ */
+short simulate_comb_table(comb_table_t *table, char *sentence);
+
+/**
+ * Save the compressed table on a binary file, in little-endian
+ *
+ * @table: Pointer to table struct
+ * @stream: Path of binary file
+ * @return: 1 if file was written, else 0
+ */
+short write_comb_table(comb_table_t *table, char *stream);
+
+/**
+ * Load the compressed table saved by write_comb_table
+ *
+ * @table: Pointer to table struct to fill
+ * @stream: Path of binary file
+ * @return: 1 if file was read, else 0
+ */
+short read_comb_table(comb_table_t *table, char *stream);
+
+/**
+ * Free memory of compressed table
+ *
+ * @table: The table want to be free
+ */
+void free_comb_table(comb_table_t *table);
+
+#endif /* AUTOMATA_TABLE_H_ */
@@ -0,0 +1,26 @@
+/*
+ ============================================================================
+ Name        : automata_trim.h
+ Author      : Eduardo Lopes
+ Version     :
+ Copyright   : MIT license
+ Description : FTC task
+ ============================================================================
+ */
+
+#ifndef AUTOMATA_TRIM_H_
+#define AUTOMATA_TRIM_H_
+
+#include "automata_convert.h"
+
+/**
+ * Remove the states that can't be reached from the initial state and the
+ * ones that can't reach a final state. If any transition is missing, a
+ * new dead state without transitions is saved on automata->dead, as the
+ * target of the empty slots of the compressed table
+ *
+ * @automata: Pointer to deterministic automata struct
+ */
+void trim_automata(af_t *automata);
+
+#endif /* AUTOMATA_TRIM_H_ */
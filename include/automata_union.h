@@ -0,0 +1,61 @@
+/*
+ ============================================================================
+ Name        : automata_union.h
+ Author      : Eduardo Lopes
+ Version     :
+ Copyright   : MIT license
+ Description : FTC task
+ ============================================================================
+ */
+
+#ifndef AUTOMATA_UNION_H_
+#define AUTOMATA_UNION_H_
+
+#include <limits.h>
+
+#include "automata_convert.h"
+
+#define SET_WORD_BITS (sizeof(unsigned long) * CHAR_BIT)
+
+/**
+ * Deterministic automata that recognizes several patterns at once. Each
+ * state keeps the set of patterns accepted when the sentence ends on it
+ */
+typedef struct union_af {
+  af_t *dfa;              // Final states accept at least one pattern
+  size_t num_patterns;
+  size_t words;           // Words of each accept set
+  unsigned long *accepts; // Accept set of each state, num_states * words
+  short *table;           // Next state of each byte, -1 if no pattern
+                          // can accept after it
+} union_af_t;
+
+/**
+ * Build the deterministic automata of union of the given automata by
+ * subset construction over all of them at once
+ *
+ * @automata: Array of non deterministic automata
+ * @count: Total of automata
+ * @result: Pointer to union struct to fill
+ */
+void union_convert(af_t **automata, size_t count, union_af_t *result);
+
+/**
+ * Test a given sentence on all patterns with one pass
+ *
+ * @automata: Pointer to union struct
+ * @sentence: Sentence to automata test
+ * @matches: Set with words positions, receives the accepted patterns
+ * @return: Total of patterns that accept the sentence
+ */
+size_t simulate_union(union_af_t *automata, char *sentence,
+                      unsigned long *matches);
+
+/**
+ * Free memory of union automata
+ *
+ * @automata: Pointer to union struct
+ */
+void free_union(union_af_t *automata);
+
+#endif /* AUTOMATA_UNION_H_ */
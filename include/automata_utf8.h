@@ -0,0 +1,92 @@
+/*
+ ============================================================================
+ Name        : automata_utf8.h
+ Author      : Eduardo Lopes
+ Version     :
+ Copyright   : MIT license
+ Description : FTC task
+ ============================================================================
+ */
+
+#ifndef AUTOMATA_UTF8_H_
+#define AUTOMATA_UTF8_H_
+
+#include "automata_convert.h"
+
+#define MAX_CODE_POINT 0x10FFFFUL
+
+/**
+ * Node of the byte trie built from the labels of one automata. Labels
+ * leaving the same state share the states of their common prefix
+ */
+typedef struct label_node {
+  short parent;
+  unsigned char low;
+  unsigned char high;
+  short state; // -1 if the slot is free
+} label_node_t;
+
+typedef struct label_trie {
+  label_node_t *nodes; // Open addressing hash of (parent, low, high)
+  size_t capacity;
+  size_t size;
+  short next_state; // Id of the next intermediate state
+} label_trie_t;
+
+/**
+ * Initialize an empty trie
+ *
+ * @trie: Pointer to trie struct
+ * @first_state: First id free to intermediate states
+ */
+void init_label_trie(label_trie_t *trie, short first_state);
+
+/**
+ * Free memory of trie
+ *
+ * @trie: Pointer to trie struct
+ */
+void free_label_trie(label_trie_t *trie);
+
+/**
+ * Decode the XML entities of a <read> label
+ *
+ * @raw: Text between <read> and </read>
+ * @length: Size of raw text
+ * @return: New string with the label bytes
+ */
+char *decode_label(char *raw, size_t length);
+
+/**
+ * Read a code point of an UTF-8 string
+ *
+ * @bytes: UTF-8 string
+ * @code_point: Decoded code point
+ * @return: Total of bytes read, 0 if sequence is invalid
+ */
+size_t utf8_decode(char *bytes, unsigned long *code_point);
+
+/**
+ * Write a code point as UTF-8
+ *
+ * @code_point: Code point to encode
+ * @bytes: Buffer with at least 4 positions
+ * @return: Total of bytes written
+ */
+size_t utf8_encode(unsigned long code_point, unsigned char *bytes);
+
+/**
+ * Append the byte transitions that read a label from a state to another.
+ * A label is a string, read byte by byte, or a code point range written
+ * as [first-last], read as UTF-8
+ *
+ * @automata: Pointer to automata struct
+ * @trie: Trie with the intermediate states already created
+ * @from: Origin state
+ * @to: Target state
+ * @label: Decoded label
+ */
+void lower_label(af_t *automata, label_trie_t *trie, short from, short to,
+                 char *label);
+
+#endif /* AUTOMATA_UTF8_H_ */
@@ -0,0 +1,87 @@
+/*
+ ============================================================================
+ Name        : automata_batch.c
+ Author      : Eduardo Lopes
+ Version     :
+ Copyright   : MIT license
+ Description : FTC task
+ ============================================================================
+ */
+
+#include "../include/automata_batch.h"
+
+typedef struct batch_item {
+  char *sentence;
+  size_t index; // Position on the given order
+} batch_item_t;
+
+static int compare_item(const void *a, const void *b) {
+  const batch_item_t *x = a, *y = b;
+
+  return strcmp(x->sentence, y->sentence);
+}
+
+size_t simulate_batch(af_t *automata, char **sentences, size_t count,
+                      short *accepted) {
+  batch_item_t *items = (batch_item_t *)calloc(count + 1, sizeof(batch_item_t));
+  size_t capacity = MAX_BUFFER_SIZE, depth = 0, steps = 0;
+  size_t dead_depth = (size_t)-1; // Depth where previous path died
+  short *path = (short *)calloc(capacity, sizeof(short)); // State by prefix
+  char *previous = "";
+
+  for (size_t i = 0; i < count; i++) {
+    items[i].sentence = sentences[i];
+    items[i].index = i;
+  }
+  qsort(items, count, sizeof(batch_item_t), compare_item);
+
+  path[0] = automata->start;
+  if (is_dead_state(automata, path[0]))
+    dead_depth = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    char *sentence = items[i].sentence;
+    size_t length = strlen(sentence);
+
+    // Resume from the end of the prefix shared with previous sentence
+    for (depth = 0; sentence[depth] != '\0' && sentence[depth] == previous[depth];
+         depth++)
+      ;
+    previous = sentence;
+
+    // The shared prefix already reached the dead state
+    if (depth >= dead_depth) {
+      accepted[items[i].index] = 0;
+      continue;
+    }
+
+    if (length + 1 > capacity) {
+      while (length + 1 > capacity)
+        capacity *= 2;
+      path = (short *)realloc(path, capacity * sizeof(short));
+    }
+
+    dead_depth = (size_t)-1;
+    for (; depth < length; depth++, steps++) {
+      path[depth + 1] =
+          get_next_state(automata->transitions, automata->transition_symbol,
+                         automata->num_transition, path[depth], sentence[depth]);
+
+      if (is_dead_state(automata, path[depth + 1])) {
+        dead_depth = ++depth;
+        steps++;
+        break;
+      }
+    }
+
+    if (dead_depth == (size_t)-1) {
+      accepted[items[i].index] = is_final_state(path[length], automata->end);
+    } else {
+      accepted[items[i].index] = 0;
+    }
+  }
+
+  free(items);
+  free(path);
+  return steps;
+}
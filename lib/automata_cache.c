@@ -0,0 +1,455 @@
+/*
+ ============================================================================
+ Name        : automata_cache.c
+ Author      : Eduardo Lopes
+ Version     :
+ Copyright   : MIT license
+ Description : FTC task
+ ============================================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <dirent.h>
+#include <limits.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include "../include/automata_cache.h"
+
+#define CACHE_HEADER_SIZE (4 + 4 + CACHE_KEY_SIZE + 4 + CACHE_KEY_SIZE)
+
+/*
+ * SHA-256, FIPS 180-4
+ */
+typedef struct sha256 {
+  uint32_t state[8];
+  uint64_t length;
+  unsigned char block[64];
+  size_t used;
+} sha256_t;
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+#define ROTR(x, n) ((x) >> (n) | (x) << (32 - (n)))
+
+static void sha256_init(sha256_t *hash) {
+  static const uint32_t initial[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372,
+                                      0xa54ff53a, 0x510e527f, 0x9b05688c,
+                                      0x1f83d9ab, 0x5be0cd19};
+
+  memcpy(hash->state, initial, sizeof(initial));
+  hash->length = 0;
+  hash->used = 0;
+}
+
+static void sha256_block(sha256_t *hash, const unsigned char *block) {
+  uint32_t w[64], v[8];
+
+  for (size_t i = 0; i < 16; i++)
+    w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 |
+           (uint32_t)block[4 * i + 2] << 8 | block[4 * i + 3];
+  for (size_t i = 16; i < 64; i++) {
+    uint32_t s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ w[i - 15] >> 3;
+    uint32_t s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ w[i - 2] >> 10;
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  memcpy(v, hash->state, sizeof(v));
+  for (size_t i = 0; i < 64; i++) {
+    uint32_t s1 = ROTR(v[4], 6) ^ ROTR(v[4], 11) ^ ROTR(v[4], 25);
+    uint32_t ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+    uint32_t t1 = v[7] + s1 + ch + sha256_k[i] + w[i];
+    uint32_t s0 = ROTR(v[0], 2) ^ ROTR(v[0], 13) ^ ROTR(v[0], 22);
+    uint32_t maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+
+    memmove(&v[1], &v[0], 7 * sizeof(uint32_t));
+    v[4] += t1;
+    v[0] = t1 + s0 + maj;
+  }
+
+  for (size_t i = 0; i < 8; i++)
+    hash->state[i] += v[i];
+}
+
+static void sha256_update(sha256_t *hash, const void *data, size_t size) {
+  const unsigned char *bytes = data;
+
+  hash->length += size;
+  while (size > 0) {
+    size_t n = 64 - hash->used < size ? 64 - hash->used : size;
+
+    memcpy(&hash->block[hash->used], bytes, n);
+    hash->used += n;
+    bytes += n;
+    size -= n;
+
+    if (hash->used == 64) {
+      sha256_block(hash, hash->block);
+      hash->used = 0;
+    }
+  }
+}
+
+static void sha256_final(sha256_t *hash, unsigned char *digest) {
+  uint64_t bits = hash->length * 8;
+  unsigned char pad = 0x80, length[8];
+
+  sha256_update(hash, &pad, 1);
+  pad = 0;
+  while (hash->used != 56)
+    sha256_update(hash, &pad, 1);
+
+  for (size_t i = 0; i < 8; i++)
+    length[i] = bits >> (56 - 8 * i);
+  sha256_update(hash, length, 8);
+
+  for (size_t i = 0; i < 32; i++)
+    digest[i] = hash->state[i / 4] >> (24 - 8 * (i % 4));
+}
+
+static void sha256(const void *data, size_t size, unsigned char *digest) {
+  sha256_t hash;
+
+  sha256_init(&hash);
+  sha256_update(&hash, data, size);
+  sha256_final(&hash, digest);
+}
+
+/*
+ * Growable buffer, numbers are written on little endian
+ */
+typedef struct byte_buffer {
+  unsigned char *data;
+  size_t size;
+  size_t capacity;
+} byte_buffer_t;
+
+static void put_bytes(byte_buffer_t *buffer, const void *data, size_t size) {
+  if (buffer->size + size > buffer->capacity) {
+    while (buffer->size + size > buffer->capacity)
+      buffer->capacity = buffer->capacity ? buffer->capacity * 2
+                                          : MAX_BUFFER_SIZE;
+    buffer->data = (unsigned char *)realloc(buffer->data, buffer->capacity);
+  }
+
+  memcpy(&buffer->data[buffer->size], data, size);
+  buffer->size += size;
+}
+
+static void put_number(byte_buffer_t *buffer, uint32_t value, size_t size) {
+  unsigned char bytes[4];
+
+  for (size_t i = 0; i < size; i++)
+    bytes[i] = value >> (8 * i);
+  put_bytes(buffer, bytes, size);
+}
+
+static uint32_t get_number(const unsigned char *data, size_t size) {
+  uint32_t value = 0;
+
+  for (size_t i = size; i > 0; i--)
+    value = value << 8 | data[i - 1];
+  return value;
+}
+
+static int compare_state(const void *a, const void *b) {
+  return *(const short *)a - *(const short *)b;
+}
+
+/*
+ * Write states, start, finals and transitions. Finals are sorted, but
+ * transitions keep the order of the list, get_next_state uses the first
+ * one that matches
+ */
+static void encode_automata(byte_buffer_t *buffer, af_t *automata) {
+  size_t num_end = 0;
+
+  while (automata->end[num_end] != -1)
+    num_end++;
+
+  short *end = (short *)calloc(num_end + 1, sizeof(short));
+  memcpy(end, automata->end, num_end * sizeof(short));
+  qsort(end, num_end, sizeof(short), compare_state);
+
+  put_number(buffer, count_states(automata), 4);
+  put_number(buffer, automata->start, 2);
+  put_number(buffer, num_end, 4);
+  for (size_t i = 0; i < num_end; i++)
+    put_number(buffer, end[i], 2);
+
+  put_number(buffer, automata->num_transition, 4);
+  for (size_t i = 0; i < automata->num_transition; i++) {
+    put_number(buffer, automata->transitions[i][0], 2);
+    put_number(buffer, automata->transitions[i][1], 2);
+    put_bytes(buffer, &automata->transition_symbol[i], 1);
+  }
+
+  free(end);
+}
+
+/*
+ * Read the automata written by encode_automata, checking every id
+ */
+static short decode_automata(const unsigned char *data, size_t size,
+                             af_t *automata) {
+  size_t position = 10, num_states, num_end, num_transition;
+
+  if (size < position)
+    return 0;
+
+  num_states = get_number(data, 4);
+  automata->start = get_number(&data[4], 2);
+  num_end = get_number(&data[6], 4);
+
+  if (num_states > SHRT_MAX || (size_t)automata->start >= num_states ||
+      num_end > num_states || size < position + 2 * num_end + 4)
+    return 0;
+
+  automata->num_states = num_states;
+  automata->end = (short *)calloc(num_states + 1, sizeof(short));
+  for (size_t i = 0; i < num_end; i++, position += 2) {
+    automata->end[i] = get_number(&data[position], 2);
+    if ((size_t)automata->end[i] >= num_states)
+      return 0;
+  }
+  automata->end[num_end] = -1;
+
+  num_transition = get_number(&data[position], 4);
+  position += 4;
+  if (size != position + 5 * num_transition)
+    return 0;
+
+  for (size_t i = 0; i < num_transition; i++, position += 5) {
+    short from = get_number(&data[position], 2);
+    short to = get_number(&data[position + 2], 2);
+
+    if ((size_t)from >= num_states || (size_t)to >= num_states)
+      return 0;
+    append_transition(automata, from, to, (char)data[position + 4]);
+  }
+
+  if (automata->num_transition > 0)
+    get_alphabet(automata);
+
+  return 1;
+}
+
+static char *entry_path(af_cache_t *cache, unsigned char *key, char *suffix) {
+  size_t length = strlen(cache->dir) + 2 * CACHE_KEY_SIZE + strlen(suffix) + 2;
+  char *path = (char *)calloc(length, sizeof(char));
+  size_t size = sprintf(path, "%s/", cache->dir);
+
+  for (size_t i = 0; i < CACHE_KEY_SIZE; i++)
+    size += sprintf(&path[size], "%02x", key[i]);
+  strcat(path, suffix);
+
+  return path;
+}
+
+void cache_key(af_t *automata, char *options, unsigned char *key) {
+  byte_buffer_t buffer = {NULL, 0, 0};
+
+  put_bytes(&buffer, "AFN", 3);
+  encode_automata(&buffer, automata);
+  put_number(&buffer, strlen(options), 4);
+  put_bytes(&buffer, options, strlen(options));
+
+  sha256(buffer.data, buffer.size, key);
+  free(buffer.data);
+}
+
+short cache_load(af_cache_t *cache, unsigned char *key, af_t *automata) {
+  char *path = entry_path(cache, key, ".afd");
+  unsigned char checksum[CACHE_KEY_SIZE], *data;
+  FILE *file;
+  long size;
+  short valid;
+
+  if ((file = fopen(path, "rb")) == NULL) {
+    free(path);
+    return 0;
+  }
+
+  // The whole entry is read at once
+  fseek(file, 0, SEEK_END);
+  size = ftell(file);
+  rewind(file);
+
+  data = (unsigned char *)malloc(size > 0 ? size : 1);
+  valid = size >= CACHE_HEADER_SIZE &&
+          fread(data, 1, size, file) == (size_t)size &&
+          memcmp(data, CACHE_MAGIC, 4) == 0 &&
+          get_number(&data[4], 4) == CACHE_VERSION &&
+          memcmp(&data[8], key, CACHE_KEY_SIZE) == 0 &&
+          get_number(&data[8 + CACHE_KEY_SIZE], 4) ==
+              size - CACHE_HEADER_SIZE;
+  fclose(file);
+
+  if (valid) {
+    sha256(&data[CACHE_HEADER_SIZE], size - CACHE_HEADER_SIZE, checksum);
+    valid = memcmp(checksum, &data[CACHE_HEADER_SIZE - CACHE_KEY_SIZE],
+                   CACHE_KEY_SIZE) == 0;
+  }
+
+  if (valid) {
+    valid = decode_automata(&data[CACHE_HEADER_SIZE], size - CACHE_HEADER_SIZE,
+                            automata);
+    if (!valid) {
+      for (size_t i = 0; i < automata->num_transition; i++)
+        free(automata->transitions[i]);
+      free(automata->transitions);
+      free(automata->transition_symbol);
+      free(automata->alphabet);
+      free(automata->end);
+      init_automata(automata);
+    }
+  }
+
+  if (valid) {
+    utime(path, NULL); // Most recently used
+  } else {
+    puts("Invalid cache entry, removed");
+    remove(path);
+  }
+
+  free(data);
+  free(path);
+  return valid;
+}
+
+short cache_store(af_cache_t *cache, unsigned char *key, af_t *automata) {
+  byte_buffer_t payload = {NULL, 0, 0}, entry = {NULL, 0, 0};
+  unsigned char checksum[CACHE_KEY_SIZE];
+  char *path = entry_path(cache, key, ".afd"), *temp, suffix[32];
+  FILE *file;
+  short stored = 0;
+
+  mkdir(cache->dir, 0755);
+
+  encode_automata(&payload, automata);
+  sha256(payload.data, payload.size, checksum);
+
+  put_bytes(&entry, CACHE_MAGIC, 4);
+  put_number(&entry, CACHE_VERSION, 4);
+  put_bytes(&entry, key, CACHE_KEY_SIZE);
+  put_number(&entry, payload.size, 4);
+  put_bytes(&entry, checksum, CACHE_KEY_SIZE);
+  put_bytes(&entry, payload.data, payload.size);
+
+  // Readers never see a partial entry, it's renamed when complete
+  sprintf(suffix, ".tmp.%ld", (long)getpid());
+  temp = entry_path(cache, key, suffix);
+
+  if ((file = fopen(temp, "wb")) != NULL) {
+    stored = fwrite(entry.data, 1, entry.size, file) == entry.size &&
+             fflush(file) == 0 && fsync(fileno(file)) == 0;
+    stored = fclose(file) == 0 && stored;
+    stored = stored && rename(temp, path) == 0;
+  }
+
+  if (!stored) {
+    puts("Can't write the cache entry");
+    remove(temp);
+  }
+
+  free(payload.data);
+  free(entry.data);
+  free(temp);
+  free(path);
+
+  cache_evict(cache);
+  return stored;
+}
+
+typedef struct cache_entry {
+  char *path;
+  size_t size;
+  time_t used;
+} cache_entry_t;
+
+static int compare_entry(const void *a, const void *b) {
+  const cache_entry_t *x = a, *y = b;
+
+  return (x->used > y->used) - (x->used < y->used);
+}
+
+void cache_evict(af_cache_t *cache) {
+  DIR *dir;
+  struct dirent *item;
+  struct stat info;
+  size_t count = 0, capacity = MAX_BUFFER_SIZE, total = 0;
+  cache_entry_t *entries;
+  time_t now = time(NULL);
+
+  if ((dir = opendir(cache->dir)) == NULL)
+    return;
+
+  entries = (cache_entry_t *)calloc(capacity, sizeof(cache_entry_t));
+  while ((item = readdir(dir)) != NULL) {
+    size_t length = strlen(item->d_name);
+    short temporary = strstr(item->d_name, ".tmp.") != NULL;
+    char *path;
+
+    if (!temporary &&
+        (length < 4 || strcmp(&item->d_name[length - 4], ".afd") != 0))
+      continue;
+
+    path = (char *)calloc(strlen(cache->dir) + length + 2, sizeof(char));
+    sprintf(path, "%s/%s", cache->dir, item->d_name);
+    if (stat(path, &info) != 0) {
+      free(path);
+      continue;
+    }
+
+    // Left by a writer that died before the rename
+    if (temporary && now - info.st_mtime > CACHE_TMP_TIMEOUT) {
+      remove(path);
+      free(path);
+      continue;
+    }
+
+    // A recent one is still being written, it only counts on the size
+    if (temporary) {
+      total += info.st_size;
+      free(path);
+      continue;
+    }
+
+    if (count == capacity) {
+      capacity *= 2;
+      entries = (cache_entry_t *)realloc(entries,
+                                         capacity * sizeof(cache_entry_t));
+    }
+    entries[count].path = path;
+    entries[count].size = info.st_size;
+    entries[count++].used = info.st_mtime;
+    total += info.st_size;
+  }
+  closedir(dir);
+
+  // Least recently used first
+  qsort(entries, count, sizeof(cache_entry_t), compare_entry);
+  for (size_t i = 0; i < count && total > cache->max_size; i++) {
+    if (remove(entries[i].path) == 0)
+      total -= entries[i].size;
+  }
+
+  for (size_t i = 0; i < count; i++)
+    free(entries[i].path);
+  free(entries);
+}
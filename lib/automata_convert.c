@@ -9,16 +9,27 @@
  */
 
 #include "../include/automata_convert.h"
+#include "../include/automata_utf8.h"
 
 void help(char *err) {
   char *str = strrchr(err, '/');
   fprintf(
       stdout,
       "Runtime error\n"
-      "Use: %s file.jff\n"
+      "Use: %s file.jff [file.jff ...] [options]\n"
+      "     %s -l file\n"
       "Use a JFLAP file in the first argument\n"
-      "The JFLAP file should contain non-deterministic automata specification\n",
-      &str[1]);
+      "With more than one file, the sentence is tested on all of them at once\n"
+      "The JFLAP file should contain non-deterministic automata specification\n"
+      "Options, only with one file:\n"
+      "  -t          Remove useless states, and stop early on the dead ones\n"
+      "  -b          Renumber states in BFS order from the initial state\n"
+      "  -p file     Renumber states by visits of the sentences in file\n"
+      "  -c dir      Keep the converted automata on a cache directory\n"
+      "  -s file     Test each sentence of file, one per line\n"
+      "  -z file     Simulate on compressed table and save it on binary file\n"
+      "  -l file     Simulate on compressed table saved by -z, alone\n",
+      &str[1], &str[1]);
 }
 
 void show_automata(af_t *automata) {
@@ -45,6 +56,10 @@ void show_automata(af_t *automata) {
     fprintf(stdout, "End state %i: %i\n", cnt + 1, automata->end[cnt]);
     cnt++;
   }
+
+  if (automata->dead != -1) {
+    fprintf(stdout, "Dead state: %i\n", automata->dead);
+  }
 }
 
 void automata_file_parser(char *stream, af_t *automata) {
@@ -63,6 +78,65 @@ void automata_file_parser(char *stream, af_t *automata) {
   }
 }
 
+/*
+ * Read the whole line, even if it is bigger than the buffer
+ */
+static char *read_line(FILE *file) {
+  size_t length = 0, size = MAX_BUFFER_SIZE;
+  char *line = (char *)calloc(size, sizeof(char));
+
+  while (fgets(&line[length], size - length, file) != NULL) {
+    length += strlen(&line[length]);
+    if (line[length - 1] == '\n')
+      break;
+    size *= 2;
+    line = (char *)realloc(line, size);
+  }
+
+  if (length == 0) {
+    free(line);
+    return NULL;
+  }
+
+  return line;
+}
+
+char **read_sentences(char *stream, size_t *count) {
+  FILE *file;
+  size_t capacity = MAX_BUFFER_SIZE;
+  char **sentences, *line;
+
+  *count = 0;
+  if ((file = fopen(stream, "r")) == NULL) {
+    puts("Can't open sentences file");
+    return NULL;
+  }
+
+  sentences = (char **)calloc(capacity, sizeof(char *));
+
+  while ((line = read_line(file)) != NULL) {
+    size_t length = strlen(line);
+
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+      line[--length] = '\0';
+
+    if (*count == capacity) {
+      capacity *= 2;
+      sentences = (char **)realloc(sentences, capacity * sizeof(char *));
+    }
+    sentences[(*count)++] = line;
+  }
+
+  fclose(file);
+  return sentences;
+}
+
+void free_sentences(char **sentences, size_t count) {
+  for (size_t i = 0; i < count; i++)
+    free(sentences[i]);
+  free(sentences);
+}
+
 void init_automata(af_t *automata) {
   automata->start = 0;
   automata->end = NULL;
@@ -72,6 +146,7 @@ void init_automata(af_t *automata) {
   automata->transitions = NULL;
   automata->alphabet = NULL;
   automata->alphabet_size = 0;
+  automata->dead = -1;
 }
 
 void get_states(FILE *file, af_t *automata) {
@@ -111,38 +186,91 @@ void get_states(FILE *file, af_t *automata) {
 }
 
 void get_transitions(FILE *file, af_t *automata) {
-  char *buffer = (char *)calloc(MAX_BUFFER_SIZE, sizeof(char));
-  char symbol[MAX_BUFFER_SIZE];
-  short transition[MAX_BUFFER_SIZE][2];
+  size_t size = 0, capacity = MAX_BUFFER_SIZE;
+  short (*pairs)[2] = calloc(capacity, sizeof(*pairs));
+  char **labels = (char **)calloc(capacity, sizeof(char *));
+  short from = 0, to = 0, first_state = automata->num_states;
+  char *line, *label = NULL, *tmp, *end;
+
+  // Save each transition with its whole label
+  while ((line = read_line(file)) != NULL) {
+    if ((tmp = strstr(line, "<from>")) != NULL)
+      sscanf(tmp, "<from>%hi</from>", &from);
+
+    if ((tmp = strstr(line, "<to>")) != NULL)
+      sscanf(tmp, "<to>%hi</to>", &to);
+
+    if ((tmp = strstr(line, "<read>")) != NULL &&
+        (end = strstr(tmp, "</read>")) != NULL) {
+      free(label);
+      label = decode_label(tmp + 6, end - tmp - 6);
+    }
 
-  do {
-    fgets(buffer, MAX_BUFFER_SIZE, file);
+    if (strstr(line, "</transition>") != NULL) {
+      if (size == capacity) {
+        capacity *= 2;
+        pairs = realloc(pairs, capacity * sizeof(*pairs));
+        labels = (char **)realloc(labels, capacity * sizeof(char *));
+      }
+      pairs[size][0] = from;
+      pairs[size][1] = to;
+      labels[size++] = label;
+
+      if (from >= first_state)
+        first_state = from + 1;
+      if (to >= first_state)
+        first_state = to + 1;
+      label = NULL;
+    }
 
-    if (strstr(buffer, "<transition>") != NULL) {
-      fscanf(file,
-             "\t\t\t<from>%hi</from>\n\r\t\t\t<to>%hi</to>\n\r\t\t\t<read>%c</"
-             "read>",
-             &transition[automata->num_transition][0],
-             &transition[automata->num_transition][1],
-             &symbol[automata->num_transition]);
+    free(line);
+  }
 
-      automata->num_transition++;
+  if (automata->start >= first_state)
+    first_state = automata->start + 1;
+  for (size_t i = 0; automata->end[i] != -1; i++) {
+    if (automata->end[i] >= first_state)
+      first_state = automata->end[i] + 1;
+  }
+
+  // Lower the labels to byte transitions, after the last state of file
+  label_trie_t trie;
+  init_label_trie(&trie, first_state);
+
+  for (size_t i = 0; i < size; i++) {
+    if (labels[i] == NULL || labels[i][0] == '\0') {
+      puts("Empty transitions are not supported, ignored");
+    } else {
+      lower_label(automata, &trie, pairs[i][0], pairs[i][1], labels[i]);
     }
-  } while (!feof(file));
+    free(labels[i]);
+  }
+  automata->num_states = trie.next_state;
 
-  automata->transition_symbol =
-      (char *)calloc(automata->num_transition, sizeof(char));
-  automata->transitions =
-      (short **)calloc(automata->num_transition, sizeof(short *));
+  free_label_trie(&trie);
+  free(label);
+  free(labels);
+  free(pairs);
+}
 
-  for (size_t i = 0; i < automata->num_transition; i++) {
-    automata->transitions[i] = (short *)calloc(2, sizeof(short));
-    automata->transitions[i][0] = transition[i][0];
-    automata->transitions[i][1] = transition[i][1];
-    automata->transition_symbol[i] = symbol[i];
+void append_transition(af_t *automata, short from, short to, char symbol) {
+  size_t size = automata->num_transition;
+
+  // The arrays have MAX_BUFFER_SIZE positions, doubled when they are full
+  if (size == 0 || (size >= MAX_BUFFER_SIZE && (size & (size - 1)) == 0)) {
+    size_t capacity = size < MAX_BUFFER_SIZE ? MAX_BUFFER_SIZE : size * 2;
+
+    automata->transitions =
+        (short **)realloc(automata->transitions, capacity * sizeof(short *));
+    automata->transition_symbol =
+        (char *)realloc(automata->transition_symbol, capacity * sizeof(char));
   }
 
-  free(buffer);
+  automata->transitions[size] = (short *)calloc(2, sizeof(short));
+  automata->transitions[size][0] = from;
+  automata->transitions[size][1] = to;
+  automata->transition_symbol[size] = symbol;
+  automata->num_transition++;
 }
 
 void get_alphabet(af_t *automata) {
@@ -298,6 +426,8 @@ void link_transitions(af_t *automata, transition_t *transition_list) {
         new[1] =
             get_next_state(automata->transitions, automata->transition_symbol,
                            automata->num_transition, aux->to, aux->symbol);
+        if (new[1] == -1)
+          new[1] = aux->to;
 
         if (is_final_state(new[1], automata->end)) {
           short end[automata->num_states], k = 0;
@@ -415,61 +545,89 @@ short is_non_deterministic_transaction(transition_t *new_automata,
 }
 
 short simulate_automata(af_t *automata, char *sentence) {
-  short state = automata->start, j = 0;
+  short state = automata->start;
 
-  while (sentence[j] != '\0') {
+  for (size_t j = 0; sentence[j] != '\0'; j++) {
     state = get_next_state(automata->transitions, automata->transition_symbol,
                            automata->num_transition, state, sentence[j]);
-    j++;
+
+    if (is_dead_state(automata, state))
+      return 0;
   }
 
   return is_final_state(state, automata->end);
 }
 
+short is_dead_state(af_t *automata, short state) {
+  return state == -1 || state == automata->dead;
+}
+
 short get_next_state(short **state, char *symbols, size_t size, int actual,
                      char symbol) {
-  size_t i = 0, round = 0;
-
-  while (round < 2) {
-    if (symbol == symbols[i]) {
-      if (actual == state[i][0]) {
-        return state[i][1];
-      }
+  for (size_t i = 0; i < size; i++) {
+    if (symbol == symbols[i] && actual == state[i][0]) {
+      return state[i][1];
     }
+  }
 
-    if (i >= size) { // Go to initial element of array
-      i = 0;
-      round++;
-    } else {
-      i++;
+  return -1;
+}
+
+size_t count_states(af_t *automata) {
+  size_t total = automata->num_states;
+
+  if ((size_t)automata->start + 1 > total)
+    total = automata->start + 1;
+  if (automata->dead != -1 && (size_t)automata->dead + 1 > total)
+    total = automata->dead + 1;
+
+  for (size_t i = 0; i < automata->num_transition; i++) {
+    for (int j = 0; j < 2; j++) {
+      if ((size_t)automata->transitions[i][j] + 1 > total)
+        total = automata->transitions[i][j] + 1;
     }
   }
 
-  return (short)actual;
+  for (size_t i = 0; automata->end[i] != -1; i++) {
+    if ((size_t)automata->end[i] + 1 > total)
+      total = automata->end[i] + 1;
+  }
+
+  return total;
 }
 
 short is_final_state(short state, short *end) {
-  short i = 0;
-
-  while (state != end[i] && state != -1 && end[i++] != -1);
+  for (size_t i = 0; end[i] != -1; i++) {
+    if (state == end[i])
+      return 1;
+  }
 
-  if (state == end[i])
-    return 1;
-  else
-    return 0;
+  return 0;
 }
 
 void create_automata_file(af_t *automata, char *stream) {
   FILE *file;
+  char *encoding = "UTF-8";
+
+  /*
+   * Labels are single bytes, and a byte of a multi-byte UTF-8 sequence
+   * isn't a valid UTF-8 text alone. Latin-1 maps every byte to one
+   * character, so the file stays valid XML and is read back byte by byte
+   */
+  for (size_t i = 0; i < automata->num_transition; i++) {
+    if ((unsigned char)automata->transition_symbol[i] >= 0x80)
+      encoding = "ISO-8859-1";
+  }
 
   if ((file = fopen(stream, "w")) != NULL) {
     // Header
-    fputs("<?xml version=\"1.0\" encoding=\"UTF-8\" "
-          "standalone=\"no\"?><!--Created with JFLAP 6.4.--><structure>\n"
-          "\t<type>fa</type>\n"
-          "\t<automaton>\n"
-          "\t\t<!--The list of states.-->\n",
-          file);
+    fprintf(file,
+            "<?xml version=\"1.0\" encoding=\"%s\" "
+            "standalone=\"no\"?><!--Created with JFLAP 6.4.--><structure>\n"
+            "\t<type>fa</type>\n"
+            "\t<automaton>\n"
+            "\t\t<!--The list of states.-->\n",
+            encoding);
 
     for (size_t i = 0; i < automata->num_states; i++) {
       fprintf(file,
@@ -477,7 +635,7 @@ void create_automata_file(af_t *automata, char *stream) {
               "\t\t\t<x>%3.02f</x>\n"
               "\t\t\t<y>%3.02f</y>\n",
               i, i, (float)(rand() % 200), (float)(rand() % 200));
-      if (i == 0) {
+      if (i == (size_t)automata->start) {
         fputs("\t\t\t<initial/>\n", file);
       }
       if (is_final_state(i, automata->end)) {
@@ -488,14 +646,22 @@ void create_automata_file(af_t *automata, char *stream) {
 
     fputs("\t\t<!--The list of transitions.-->\n", file);
     for (size_t i = 0; i < automata->num_transition; i++) {
+      unsigned char symbol = automata->transition_symbol[i];
+      char read[8] = {symbol, '\0'};
+
+      // Control bytes as references, so the label stays on its line
+      if (symbol < 0x20 || symbol == 0x7F)
+        sprintf(read, "&#%u;", symbol);
+
       fprintf(file,
               "\t\t<transition>\n"
               "\t\t\t<from>%i</from>\n"
               "\t\t\t<to>%i</to>\n"
-              "\t\t\t<read>%c</read>\n"
+              "\t\t\t<read>%s</read>\n"
               "\t\t</transition>\n",
               automata->transitions[i][0], automata->transitions[i][1],
-              automata->transition_symbol[i]);
+              symbol == '<' ? "&lt;" : symbol == '>' ? "&gt;"
+              : symbol == '&' ? "&amp;" : read);
     }
 
     fputs("\t</automaton>\n"
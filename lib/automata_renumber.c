@@ -0,0 +1,149 @@
+/*
+ ============================================================================
+ Name        : automata_renumber.c
+ Author      : Eduardo Lopes
+ Version     :
+ Copyright   : MIT license
+ Description : FTC task
+ ============================================================================
+ */
+
+#include "../include/automata_renumber.h"
+
+typedef struct state_rank {
+  size_t visits;
+  size_t order; // Position on BFS from the initial state
+  short state;
+} state_rank_t;
+
+typedef struct edge {
+  short from;
+  short to;
+  char symbol;
+  size_t index; // Position on transitions list, the first match wins
+} edge_t;
+
+static int compare_rank(const void *a, const void *b) {
+  const state_rank_t *x = a, *y = b;
+
+  if (x->visits != y->visits)
+    return x->visits > y->visits ? -1 : 1; // Hot states first
+  if (x->order != y->order)
+    return x->order < y->order ? -1 : 1;
+  return 0;
+}
+
+static int compare_edge(const void *a, const void *b) {
+  const edge_t *x = a, *y = b;
+
+  if (x->from != y->from)
+    return x->from - y->from;
+  if (x->symbol != y->symbol)
+    return (unsigned char)x->symbol - (unsigned char)y->symbol;
+  return x->index < y->index ? -1 : x->index > y->index;
+}
+
+void profile_automata(af_t *automata, char *sentence, size_t *visits) {
+  short state = automata->start;
+
+  visits[state]++;
+  for (size_t j = 0; sentence[j] != '\0'; j++) {
+    state = get_next_state(automata->transitions, automata->transition_symbol,
+                           automata->num_transition, state, sentence[j]);
+
+    if (is_dead_state(automata, state))
+      break;
+    visits[state]++;
+  }
+}
+
+void renumber_states(af_t *automata, size_t *visits) {
+  size_t num_states = count_states(automata);
+  size_t size = automata->num_transition;
+
+  // Adjacency list of each state, used by BFS
+  size_t *row = (size_t *)calloc(num_states + 1, sizeof(size_t));
+  short *adjacent = (short *)calloc(size + 1, sizeof(short));
+
+  for (size_t i = 0; i < size; i++)
+    row[automata->transitions[i][0] + 1]++;
+  for (size_t i = 0; i < num_states; i++)
+    row[i + 1] += row[i];
+
+  size_t *cursor = (size_t *)calloc(num_states, sizeof(size_t));
+  memcpy(cursor, row, num_states * sizeof(size_t));
+  for (size_t i = 0; i < size; i++)
+    adjacent[cursor[automata->transitions[i][0]]++] = automata->transitions[i][1];
+
+  // BFS from initial state, unreachable states go to the end
+  size_t *order = (size_t *)calloc(num_states, sizeof(size_t));
+  short *queue = (short *)calloc(num_states, sizeof(short));
+  size_t head = 0, tail = 0;
+
+  for (size_t i = 0; i < num_states; i++)
+    order[i] = num_states;
+
+  order[automata->start] = tail;
+  queue[tail++] = automata->start;
+  while (head < tail) {
+    short state = queue[head++];
+
+    for (size_t k = row[state]; k < row[state + 1]; k++) {
+      if (order[adjacent[k]] == num_states) {
+        order[adjacent[k]] = tail;
+        queue[tail++] = adjacent[k];
+      }
+    }
+  }
+
+  for (size_t i = 0; i < num_states; i++) {
+    if (order[i] == num_states)
+      order[i] = tail++;
+  }
+
+  state_rank_t *rank = (state_rank_t *)calloc(num_states, sizeof(state_rank_t));
+  short *new_id = (short *)calloc(num_states, sizeof(short));
+
+  for (size_t i = 0; i < num_states; i++) {
+    rank[i].visits = visits != NULL ? visits[i] : 0;
+    rank[i].order = order[i];
+    rank[i].state = i;
+  }
+  qsort(rank, num_states, sizeof(state_rank_t), compare_rank);
+
+  for (size_t i = 0; i < num_states; i++)
+    new_id[rank[i].state] = i;
+
+  // Apply the new ids, and keep the transitions of each state together
+  edge_t *edges = (edge_t *)calloc(size + 1, sizeof(edge_t));
+
+  for (size_t i = 0; i < size; i++) {
+    edges[i].from = new_id[automata->transitions[i][0]];
+    edges[i].to = new_id[automata->transitions[i][1]];
+    edges[i].symbol = automata->transition_symbol[i];
+    edges[i].index = i;
+  }
+  qsort(edges, size, sizeof(edge_t), compare_edge);
+
+  for (size_t i = 0; i < size; i++) {
+    automata->transitions[i][0] = edges[i].from;
+    automata->transitions[i][1] = edges[i].to;
+    automata->transition_symbol[i] = edges[i].symbol;
+  }
+
+  automata->start = new_id[automata->start];
+  if (automata->dead != -1)
+    automata->dead = new_id[automata->dead];
+  for (size_t i = 0; automata->end[i] != -1; i++)
+    automata->end[i] = new_id[automata->end[i]];
+  automata->num_states = num_states;
+
+  free(row);
+  free(adjacent);
+  free(cursor);
+  free(order);
+  free(queue);
+  free(rank);
+  free(new_id);
+  free(edges);
+}
@@ -0,0 +1,348 @@
+/*
+ ============================================================================
+ Name        : automata_table.c
+ Author      : Eduardo Lopes
+ Version     :
+ Copyright   : MIT license
+ Description : FTC task
+ ============================================================================
+ */
+
+#include "../include/automata_table.h"
+
+static int compare_short(const void *a, const void *b) {
+  return *(const short *)a - *(const short *)b;
+}
+
+static void put_number(FILE *file, uint32_t value, size_t size) {
+  for (size_t i = 0; i < size; i++)
+    fputc((value >> (8 * i)) & 0xFF, file);
+}
+
+static uint32_t get_number(const unsigned char *data, size_t size) {
+  uint32_t value = 0;
+
+  for (size_t i = size; i > 0; i--)
+    value = value << 8 | data[i - 1];
+  return value;
+}
+
+/*
+ * Grow next/check until it have at least size slots, new slots are free
+ */
+static void reserve_slots(comb_table_t *table, size_t *capacity, size_t size) {
+  size_t old = *capacity;
+
+  if (size <= old)
+    return;
+
+  while (*capacity < size)
+    *capacity *= 2;
+
+  table->next = (short *)realloc(table->next, *capacity * sizeof(short));
+  table->check = (short *)realloc(table->check, *capacity * sizeof(short));
+  for (size_t i = old; i < *capacity; i++) {
+    table->next[i] = -1;
+    table->check[i] = -1;
+  }
+}
+
+void build_comb_table(af_t *automata, comb_table_t *table) {
+  size_t num_states = count_states(automata), size = automata->num_transition;
+  size_t capacity = MAX_BUFFER_SIZE, first_free = 0;
+
+  table->start = automata->start;
+  table->dead = automata->dead;
+  table->num_states = num_states;
+  table->num_classes = 0;
+
+  // Each symbol of alphabet becomes a column of the table
+  for (size_t i = 0; i < 256; i++)
+    table->classes[i] = -1;
+  for (size_t i = 0; i < size; i++) {
+    unsigned char symbol = automata->transition_symbol[i];
+
+    if (table->classes[symbol] == -1)
+      table->classes[symbol] = table->num_classes++;
+  }
+
+  table->base = (int32_t *)calloc(num_states, sizeof(int32_t));
+  table->deflt = (short *)calloc(num_states, sizeof(short));
+  table->final = (char *)calloc(num_states, sizeof(char));
+  table->next = (short *)calloc(capacity, sizeof(short));
+  table->check = (short *)calloc(capacity, sizeof(short));
+  for (size_t i = 0; i < capacity; i++)
+    table->next[i] = table->check[i] = -1;
+  reserve_slots(table, &capacity, table->num_classes + 1);
+
+  for (size_t i = 0; automata->end[i] != -1; i++)
+    table->final[automata->end[i]] = 1;
+
+  // Group transitions by origin state, keeping the list order
+  size_t *row_start = (size_t *)calloc(num_states + 1, sizeof(size_t));
+  size_t *cursor = (size_t *)calloc(num_states, sizeof(size_t));
+  size_t *by_state = (size_t *)calloc(size + 1, sizeof(size_t));
+
+  for (size_t i = 0; i < size; i++)
+    row_start[automata->transitions[i][0] + 1]++;
+  for (size_t i = 0; i < num_states; i++)
+    row_start[i + 1] += row_start[i];
+  memcpy(cursor, row_start, num_states * sizeof(size_t));
+  for (size_t i = 0; i < size; i++)
+    by_state[cursor[automata->transitions[i][0]]++] = i;
+
+  short *row = (short *)calloc(table->num_classes + 1, sizeof(short));
+  short *sorted = (short *)calloc(table->num_classes + 1, sizeof(short));
+  size_t used = table->num_classes;
+
+  for (size_t state = 0; state < num_states; state++) {
+    // Dense row, the dead state (or -1) where there is no edge
+    for (size_t c = 0; c < table->num_classes; c++)
+      row[c] = automata->dead;
+    for (size_t k = row_start[state + 1]; k > row_start[state]; k--) {
+      size_t i = by_state[k - 1];
+
+      row[table->classes[(unsigned char)automata->transition_symbol[i]]] =
+          automata->transitions[i][1];
+    }
+
+    // The most common target is the default one
+    memcpy(sorted, row, table->num_classes * sizeof(short));
+    qsort(sorted, table->num_classes, sizeof(short), compare_short);
+
+    short deflt = -1;
+    size_t best = 0;
+    for (size_t c = 0, run = 0; c < table->num_classes; c++) {
+      run = (c > 0 && sorted[c] == sorted[c - 1]) ? run + 1 : 1;
+      if (run > best) {
+        best = run;
+        deflt = sorted[c];
+      }
+    }
+    table->deflt[state] = deflt;
+
+    // First fit of the remaining transitions on the comb
+    size_t first = table->num_classes;
+    for (size_t c = 0; c < table->num_classes; c++) {
+      if (row[c] != deflt) {
+        first = c;
+        break;
+      }
+    }
+
+    if (first == table->num_classes) {
+      table->base[state] = 0;
+      continue;
+    }
+
+    while (first_free < capacity && table->check[first_free] != -1)
+      first_free++;
+
+    size_t base = first_free > first ? first_free - first : 0;
+    for (;;) {
+      size_t c;
+
+      reserve_slots(table, &capacity, base + table->num_classes);
+      for (c = first; c < table->num_classes; c++) {
+        if (row[c] != deflt && table->check[base + c] != -1)
+          break;
+      }
+      if (c == table->num_classes)
+        break;
+      base++;
+    }
+
+    table->base[state] = base;
+    for (size_t c = first; c < table->num_classes; c++) {
+      if (row[c] != deflt) {
+        table->next[base + c] = row[c];
+        table->check[base + c] = state;
+      }
+    }
+    if (base + table->num_classes > used)
+      used = base + table->num_classes;
+  }
+
+  table->size = used;
+  table->next = (short *)realloc(table->next, (used + 1) * sizeof(short));
+  table->check = (short *)realloc(table->check, (used + 1) * sizeof(short));
+
+  free(row_start);
+  free(cursor);
+  free(by_state);
+  free(row);
+  free(sorted);
+}
+
+short comb_next_state(comb_table_t *table, short state, char symbol) {
+  short c = table->classes[(unsigned char)symbol];
+  size_t slot;
+
+  if (c == -1)
+    return -1;
+
+  slot = table->base[state] + c;
+  if (table->check[slot] == state)
+    return table->next[slot];
+
+  return table->deflt[state];
+}
+
+short simulate_comb_table(comb_table_t *table, char *sentence) {
+  short state = table->start;
+
+  for (size_t j = 0; sentence[j] != '\0'; j++) {
+    state = comb_next_state(table, state, sentence[j]);
+
+    if (state == -1 || state == table->dead)
+      return 0;
+  }
+
+  return table->final[state];
+}
+
+short write_comb_table(comb_table_t *table, char *stream) {
+  FILE *file;
+
+  if ((file = fopen(stream, "wb")) == NULL) {
+    puts("Can't open the table file");
+    return 0;
+  }
+
+  // Values are little-endian, like the entries of the cache
+  fwrite(COMB_TABLE_MAGIC, sizeof(char), 4, file);
+  put_number(file, COMB_TABLE_VERSION, 4);
+  put_number(file, table->num_states, 4);
+  put_number(file, table->num_classes, 4);
+  put_number(file, table->size, 4);
+  put_number(file, (uint16_t)table->start, 2);
+  put_number(file, (uint16_t)table->dead, 2);
+  for (size_t i = 0; i < 256; i++)
+    put_number(file, (uint16_t)table->classes[i], 2);
+  for (size_t i = 0; i < table->num_states; i++)
+    put_number(file, table->base[i], 4);
+  for (size_t i = 0; i < table->num_states; i++)
+    put_number(file, (uint16_t)table->deflt[i], 2);
+  fwrite(table->final, sizeof(char), table->num_states, file);
+  for (size_t i = 0; i < table->size; i++)
+    put_number(file, (uint16_t)table->next[i], 2);
+  for (size_t i = 0; i < table->size; i++)
+    put_number(file, (uint16_t)table->check[i], 2);
+
+  if (ferror(file)) {
+    fclose(file);
+    return 0;
+  }
+
+  return fclose(file) == 0;
+}
+
+short read_comb_table(comb_table_t *table, char *stream) {
+  FILE *file;
+  unsigned char *data;
+  long length;
+  size_t n, position = COMB_TABLE_HEADER_SIZE;
+
+  if ((file = fopen(stream, "rb")) == NULL) {
+    puts("Can't open the table file");
+    return 0;
+  }
+
+  if (fseek(file, 0, SEEK_END) != 0 || (length = ftell(file)) < 0 ||
+      fseek(file, 0, SEEK_SET) != 0) {
+    puts("Can't read the table file");
+    fclose(file);
+    return 0;
+  }
+
+  data = (unsigned char *)malloc(length + 1);
+  if (fread(data, sizeof(char), length, file) != (size_t)length) {
+    puts("Can't read the table file");
+    free(data);
+    fclose(file);
+    return 0;
+  }
+  fclose(file);
+
+  if ((size_t)length < COMB_TABLE_HEADER_SIZE ||
+      memcmp(data, COMB_TABLE_MAGIC, 4) != 0 ||
+      get_number(&data[4], 4) != COMB_TABLE_VERSION ||
+      get_number(&data[8], 4) > SHRT_MAX ||
+      get_number(&data[12], 4) > 256) {
+    puts("Invalid table file");
+    free(data);
+    return 0;
+  }
+
+  table->num_states = n = get_number(&data[8], 4);
+  table->num_classes = get_number(&data[12], 4);
+  table->size = get_number(&data[16], 4);
+
+  if ((size_t)length != position + 7 * n + 4 * table->size) {
+    puts("Truncated table file");
+    free(data);
+    return 0;
+  }
+
+  table->start = (int16_t)get_number(&data[20], 2);
+  table->dead = (int16_t)get_number(&data[22], 2);
+  for (size_t i = 0; i < 256; i++)
+    table->classes[i] = (int16_t)get_number(&data[24 + 2 * i], 2);
+
+  table->base = (int32_t *)calloc(n + 1, sizeof(int32_t));
+  table->deflt = (short *)calloc(n + 1, sizeof(short));
+  table->final = (char *)calloc(n + 1, sizeof(char));
+  table->next = (short *)calloc(table->size + 1, sizeof(short));
+  table->check = (short *)calloc(table->size + 1, sizeof(short));
+
+  for (size_t i = 0; i < n; i++, position += 4)
+    table->base[i] = (int32_t)get_number(&data[position], 4);
+  for (size_t i = 0; i < n; i++, position += 2)
+    table->deflt[i] = (int16_t)get_number(&data[position], 2);
+  memcpy(table->final, &data[position], n);
+  position += n;
+  for (size_t i = 0; i < table->size; i++, position += 2)
+    table->next[i] = (int16_t)get_number(&data[position], 2);
+  for (size_t i = 0; i < table->size; i++, position += 2)
+    table->check[i] = (int16_t)get_number(&data[position], 2);
+
+  free(data);
+
+  // Every row should fit on the comb, and every target should be a state
+  short valid = (size_t)table->start < n && table->dead >= -1 &&
+                (table->dead == -1 || (size_t)table->dead < n);
+
+  for (size_t i = 0; i < 256 && valid; i++) {
+    valid = table->classes[i] >= -1 &&
+            table->classes[i] < (short)table->num_classes;
+  }
+  for (size_t i = 0; i < n && valid; i++) {
+    valid = table->base[i] >= 0 &&
+            (size_t)table->base[i] + table->num_classes <= table->size &&
+            table->deflt[i] >= -1 &&
+            (table->deflt[i] == -1 || (size_t)table->deflt[i] < n);
+  }
+  for (size_t i = 0; i < table->size && valid; i++) {
+    valid = table->check[i] == -1 ||
+            ((size_t)table->check[i] < n && table->next[i] >= -1 &&
+             (table->next[i] == -1 || (size_t)table->next[i] < n));
+  }
+
+  if (!valid) {
+    puts("Invalid table file");
+    free_comb_table(table);
+  }
+
+  return valid;
+}
+
+void free_comb_table(comb_table_t *table) {
+  free(table->base);
+  free(table->deflt);
+  free(table->final);
+  free(table->next);
+  free(table->check);
+  table->base = NULL;
+  table->deflt = table->next = table->check = NULL;
+  table->final = NULL;
+}
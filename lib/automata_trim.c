@@ -0,0 +1,159 @@
+/*
+ ============================================================================
+ Name        : automata_trim.c
+ Author      : Eduardo Lopes
+ Version     :
+ Copyright   : MIT license
+ Description : FTC task
+ ============================================================================
+ */
+
+#include "../include/automata_trim.h"
+
+/*
+ * Mark every state reachable from the marked ones, following the edges
+ * from source to target
+ */
+static void mark_reachable(size_t num_states, short *source, short *target,
+                           size_t size, char *mark) {
+  size_t *row = (size_t *)calloc(num_states + 1, sizeof(size_t));
+  size_t *cursor = (size_t *)calloc(num_states + 1, sizeof(size_t));
+  short *adjacent = (short *)calloc(size + 1, sizeof(short));
+  short *queue = (short *)calloc(num_states + 1, sizeof(short));
+  size_t head = 0, tail = 0;
+
+  for (size_t i = 0; i < size; i++)
+    row[source[i] + 1]++;
+  for (size_t s = 0; s < num_states; s++)
+    row[s + 1] += row[s];
+  memcpy(cursor, row, num_states * sizeof(size_t));
+  for (size_t i = 0; i < size; i++)
+    adjacent[cursor[source[i]]++] = target[i];
+
+  for (size_t s = 0; s < num_states; s++) {
+    if (mark[s])
+      queue[tail++] = s;
+  }
+
+  while (head < tail) {
+    short state = queue[head++];
+
+    for (size_t k = row[state]; k < row[state + 1]; k++) {
+      if (!mark[adjacent[k]]) {
+        mark[adjacent[k]] = 1;
+        queue[tail++] = adjacent[k];
+      }
+    }
+  }
+
+  free(row);
+  free(cursor);
+  free(adjacent);
+  free(queue);
+}
+
+void trim_automata(af_t *automata) {
+  size_t num_states = count_states(automata), size = 0, num_symbols = 0;
+  char *reach = (char *)calloc(num_states, sizeof(char));
+  char *coreach = (char *)calloc(num_states, sizeof(char));
+  char *seen = (char *)calloc(num_states * 256 + 1, sizeof(char));
+  short *from = (short *)calloc(automata->num_transition + 1, sizeof(short));
+  short *to = (short *)calloc(automata->num_transition + 1, sizeof(short));
+  char *symbol = (char *)calloc(automata->num_transition + 1, sizeof(char));
+  char symbols[256], used[256] = {0};
+
+  // Only the first transition of each state and symbol is ever taken
+  for (size_t i = 0; i < automata->num_transition; i++) {
+    short state = automata->transitions[i][0];
+    unsigned char c = automata->transition_symbol[i];
+
+    if (!used[c]) {
+      used[c] = 1;
+      symbols[num_symbols++] = c;
+    }
+
+    if (!seen[state * 256 + c]) {
+      seen[state * 256 + c] = 1;
+      from[size] = state;
+      to[size] = automata->transitions[i][1];
+      symbol[size++] = c;
+    }
+  }
+
+  reach[automata->start] = 1;
+  mark_reachable(num_states, from, to, size, reach);
+
+  for (size_t i = 0; automata->end[i] != -1; i++)
+    coreach[automata->end[i]] = 1;
+  mark_reachable(num_states, to, from, size, coreach);
+
+  // Useful states keep their order, the initial one is always kept
+  short *new_id = (short *)calloc(num_states, sizeof(short));
+  size_t count = 0;
+
+  for (size_t s = 0; s < num_states; s++) {
+    if ((reach[s] && coreach[s]) || s == (size_t)automata->start)
+      new_id[s] = count++;
+    else
+      new_id[s] = -1;
+  }
+
+  af_t trimmed;
+  init_automata(&trimmed);
+  trimmed.start = new_id[automata->start];
+
+  if (!coreach[automata->start]) {
+    // Empty language, initial state is already dead
+    trimmed.dead = trimmed.start;
+  } else {
+    memset(seen, 0, count * 256);
+
+    for (size_t i = 0; i < size; i++) {
+      if (new_id[from[i]] != -1 && new_id[to[i]] != -1) {
+        append_transition(&trimmed, new_id[from[i]], new_id[to[i]], symbol[i]);
+        seen[new_id[from[i]] * 256 + (unsigned char)symbol[i]] = 1;
+      }
+    }
+
+    /*
+     * A missing transition leads to the dead state. The list engines
+     * already stop on it, so only its id is kept, and the tables send
+     * their empty slots to it
+     */
+    for (size_t s = 0; s < count && trimmed.dead == -1; s++) {
+      for (size_t c = 0; c < num_symbols; c++) {
+        if (!seen[s * 256 + (unsigned char)symbols[c]])
+          trimmed.dead = count;
+      }
+    }
+  }
+
+  trimmed.num_states = count + (trimmed.dead == (short)count);
+  trimmed.end = (short *)calloc(trimmed.num_states + 1, sizeof(short));
+
+  size_t k = 0;
+  for (size_t i = 0; automata->end[i] != -1; i++) {
+    if (new_id[automata->end[i]] != -1 && coreach[automata->start])
+      trimmed.end[k++] = new_id[automata->end[i]];
+  }
+  trimmed.end[k] = -1;
+
+  if (trimmed.num_transition > 0)
+    get_alphabet(&trimmed);
+
+  for (size_t i = 0; i < automata->num_transition; i++)
+    free(automata->transitions[i]);
+  free(automata->transitions);
+  free(automata->transition_symbol);
+  free(automata->alphabet);
+  free(automata->end);
+  memcpy(automata, &trimmed, sizeof(af_t));
+
+  free(reach);
+  free(coreach);
+  free(seen);
+  free(from);
+  free(to);
+  free(symbol);
+  free(new_id);
+}
@@ -0,0 +1,340 @@
+/*
+ ============================================================================
+ Name        : automata_union.c
+ Author      : Eduardo Lopes
+ Version     :
+ Copyright   : MIT license
+ Description : FTC task
+ ============================================================================
+ */
+
+#include "../include/automata_union.h"
+
+#define TABLE_COLUMNS 256
+
+/*
+ * Subsets of non deterministic states already converted to a state
+ */
+typedef struct subset_map {
+  short *slots; // Deterministic state of each slot, -1 if free
+  size_t capacity;
+  size_t size;
+  unsigned long *sets; // Subset of each deterministic state
+  size_t words;
+  size_t sets_capacity;
+} subset_map_t;
+
+static size_t hash_subset(unsigned long *set, size_t words) {
+  size_t hash = 14695981039346656037UL;
+
+  for (size_t i = 0; i < words; i++) {
+    hash ^= set[i];
+    hash *= 1099511628211UL;
+  }
+
+  return hash ^ (hash >> 29);
+}
+
+static short *find_subset(subset_map_t *map, unsigned long *set) {
+  size_t i = hash_subset(set, map->words) & (map->capacity - 1);
+
+  while (map->slots[i] != -1 &&
+         memcmp(&map->sets[map->slots[i] * map->words], set,
+                map->words * sizeof(unsigned long)) != 0)
+    i = (i + 1) & (map->capacity - 1);
+
+  return &map->slots[i];
+}
+
+/*
+ * Return the state of the subset, creating it if it's new. Return -1 if
+ * there are no more state ids
+ */
+static short add_subset(subset_map_t *map, unsigned long *set,
+                        short **table) {
+  short *slot = find_subset(map, set);
+
+  if (*slot != -1)
+    return *slot;
+
+  if (map->size == SHRT_MAX)
+    return -1;
+
+  if (map->size == map->sets_capacity) {
+    map->sets_capacity *= 2;
+    map->sets = (unsigned long *)realloc(
+        map->sets, map->sets_capacity * map->words * sizeof(unsigned long));
+    *table = (short *)realloc(*table, map->sets_capacity * TABLE_COLUMNS *
+                                          sizeof(short));
+  }
+
+  memcpy(&map->sets[map->size * map->words], set,
+         map->words * sizeof(unsigned long));
+  for (size_t b = 0; b < TABLE_COLUMNS; b++)
+    (*table)[map->size * TABLE_COLUMNS + b] = -1;
+  *slot = map->size++;
+
+  // Keep the map half empty
+  if (map->size * 2 > map->capacity) {
+    free(map->slots);
+    map->capacity *= 2;
+    map->slots = (short *)malloc(map->capacity * sizeof(short));
+    for (size_t i = 0; i < map->capacity; i++)
+      map->slots[i] = -1;
+    for (size_t d = 0; d < map->size; d++)
+      *find_subset(map, &map->sets[d * map->words]) = d;
+  }
+
+  return map->size - 1;
+}
+
+/*
+ * Send to -1 every transition to a state that can't reach an accept set,
+ * so simulation stops as soon as no pattern can accept the sentence
+ */
+static void prune_dead_states(union_af_t *result, size_t num_states) {
+  size_t *row = (size_t *)calloc(num_states + 1, sizeof(size_t));
+  size_t *cursor = (size_t *)calloc(num_states + 1, sizeof(size_t));
+  short *source =
+      (short *)calloc(num_states * TABLE_COLUMNS + 1, sizeof(short));
+  short *queue = (short *)calloc(num_states + 1, sizeof(short));
+  char *live = (char *)calloc(num_states + 1, sizeof(char));
+  short *table = result->table;
+  size_t head = 0, tail = 0;
+
+  // Reverse edges, grouped by target state
+  for (size_t i = 0; i < num_states * TABLE_COLUMNS; i++) {
+    if (table[i] != -1)
+      row[table[i] + 1]++;
+  }
+  for (size_t d = 0; d < num_states; d++)
+    row[d + 1] += row[d];
+  memcpy(cursor, row, num_states * sizeof(size_t));
+  for (size_t i = 0; i < num_states * TABLE_COLUMNS; i++) {
+    if (table[i] != -1)
+      source[cursor[table[i]]++] = i / TABLE_COLUMNS;
+  }
+
+  for (size_t d = 0; d < num_states; d++) {
+    for (size_t w = 0; w < result->words; w++) {
+      if (result->accepts[d * result->words + w] != 0) {
+        live[d] = 1;
+        queue[tail++] = d;
+        break;
+      }
+    }
+  }
+
+  while (head < tail) {
+    short state = queue[head++];
+
+    for (size_t k = row[state]; k < row[state + 1]; k++) {
+      if (!live[source[k]]) {
+        live[source[k]] = 1;
+        queue[tail++] = source[k];
+      }
+    }
+  }
+
+  for (size_t i = 0; i < num_states * TABLE_COLUMNS; i++) {
+    if (table[i] != -1 && !live[table[i]])
+      table[i] = -1;
+  }
+
+  free(row);
+  free(cursor);
+  free(source);
+  free(queue);
+  free(live);
+}
+
+void union_convert(af_t **automata, size_t count, union_af_t *result) {
+  size_t total = 0, total_edges = 0;
+  size_t *offset = (size_t *)calloc(count + 1, sizeof(size_t));
+
+  // All automata share one numbering of states
+  for (size_t k = 0; k < count; k++) {
+    offset[k] = total;
+    total += count_states(automata[k]);
+    total_edges += automata[k]->num_transition;
+  }
+
+  size_t *row = (size_t *)calloc(total + 1, sizeof(size_t));
+  size_t *cursor = (size_t *)calloc(total + 1, sizeof(size_t));
+  size_t *edge_to = (size_t *)calloc(total_edges + 1, sizeof(size_t));
+  unsigned char *edge_symbol =
+      (unsigned char *)calloc(total_edges + 1, sizeof(unsigned char));
+  long *final_of = (long *)calloc(total + 1, sizeof(long));
+
+  for (size_t k = 0; k < count; k++) {
+    for (size_t i = 0; i < automata[k]->num_transition; i++)
+      row[offset[k] + automata[k]->transitions[i][0] + 1]++;
+  }
+  for (size_t s = 0; s < total; s++)
+    row[s + 1] += row[s];
+  memcpy(cursor, row, total * sizeof(size_t));
+
+  for (size_t k = 0; k < count; k++) {
+    for (size_t i = 0; i < automata[k]->num_transition; i++) {
+      size_t e = cursor[offset[k] + automata[k]->transitions[i][0]]++;
+
+      edge_to[e] = offset[k] + automata[k]->transitions[i][1];
+      edge_symbol[e] = automata[k]->transition_symbol[i];
+    }
+  }
+
+  for (size_t s = 0; s < total; s++)
+    final_of[s] = -1;
+  for (size_t k = 0; k < count; k++) {
+    for (size_t i = 0; automata[k]->end[i] != -1; i++)
+      final_of[offset[k] + automata[k]->end[i]] = k;
+  }
+
+  subset_map_t map;
+  map.words = total / SET_WORD_BITS + 1;
+  map.size = 0;
+  map.capacity = map.sets_capacity = MAX_BUFFER_SIZE;
+  map.slots = (short *)malloc(map.capacity * sizeof(short));
+  map.sets = (unsigned long *)calloc(map.sets_capacity * map.words,
+                                     sizeof(unsigned long));
+  for (size_t i = 0; i < map.capacity; i++)
+    map.slots[i] = -1;
+
+  short *table =
+      (short *)malloc(map.sets_capacity * TABLE_COLUMNS * sizeof(short));
+  unsigned long *next = (unsigned long *)calloc(TABLE_COLUMNS * map.words,
+                                                sizeof(unsigned long));
+  char used[TABLE_COLUMNS];
+  short full = 0;
+
+  // Initial state is the set with the initial state of each automata
+  for (size_t k = 0; k < count; k++) {
+    size_t s = offset[k] + automata[k]->start;
+    next[s / SET_WORD_BITS] |= 1UL << (s % SET_WORD_BITS);
+  }
+  add_subset(&map, next, &table);
+
+  for (size_t d = 0; d < map.size && !full; d++) {
+    memset(next, 0, TABLE_COLUMNS * map.words * sizeof(unsigned long));
+    memset(used, 0, sizeof(used));
+
+    for (size_t w = 0; w < map.words; w++) {
+      unsigned long bits = map.sets[d * map.words + w];
+
+      for (size_t bit = 0; bits != 0; bit++, bits >>= 1) {
+        size_t s = w * SET_WORD_BITS + bit;
+
+        if (!(bits & 1UL))
+          continue;
+
+        for (size_t e = row[s]; e < row[s + 1]; e++) {
+          unsigned long *target = &next[edge_symbol[e] * map.words];
+
+          target[edge_to[e] / SET_WORD_BITS] |= 1UL
+                                                << (edge_to[e] % SET_WORD_BITS);
+          used[edge_symbol[e]] = 1;
+        }
+      }
+    }
+
+    for (size_t b = 0; b < TABLE_COLUMNS; b++) {
+      if (used[b]) {
+        short state = add_subset(&map, &next[b * map.words], &table);
+
+        if (state == -1) {
+          puts("Too many states on union automata");
+          full = 1;
+          break;
+        }
+        table[d * TABLE_COLUMNS + b] = state;
+      }
+    }
+  }
+
+  // Patterns accepted by each state
+  result->num_patterns = count;
+  result->words = count / SET_WORD_BITS + 1;
+  result->accepts = (unsigned long *)calloc(map.size * result->words,
+                                            sizeof(unsigned long));
+  result->table = table;
+
+  for (size_t d = 0; d < map.size; d++) {
+    for (size_t s = 0; s < total; s++) {
+      if (final_of[s] != -1 &&
+          (map.sets[d * map.words + s / SET_WORD_BITS] >> (s % SET_WORD_BITS) &
+           1UL))
+        result->accepts[d * result->words + final_of[s] / SET_WORD_BITS] |=
+            1UL << (final_of[s] % SET_WORD_BITS);
+    }
+  }
+
+  prune_dead_states(result, map.size);
+
+  // Same automata on the usual representation
+  af_t *dfa = (af_t *)malloc(sizeof(af_t));
+  size_t k = 0;
+
+  init_automata(dfa);
+  dfa->num_states = map.size;
+  dfa->end = (short *)calloc(map.size + 1, sizeof(short));
+
+  for (size_t d = 0; d < map.size; d++) {
+    for (size_t b = 0; b < TABLE_COLUMNS; b++) {
+      if (table[d * TABLE_COLUMNS + b] != -1)
+        append_transition(dfa, d, table[d * TABLE_COLUMNS + b], (char)b);
+    }
+
+    for (size_t w = 0; w < result->words; w++) {
+      if (result->accepts[d * result->words + w] != 0) {
+        dfa->end[k++] = d;
+        break;
+      }
+    }
+  }
+  dfa->end[k] = -1;
+
+  if (dfa->num_transition > 0)
+    get_alphabet(dfa);
+  result->dfa = dfa;
+
+  free(offset);
+  free(row);
+  free(cursor);
+  free(edge_to);
+  free(edge_symbol);
+  free(final_of);
+  free(map.slots);
+  free(map.sets);
+  free(next);
+}
+
+size_t simulate_union(union_af_t *automata, char *sentence,
+                      unsigned long *matches) {
+  short state = 0;
+  size_t total = 0;
+
+  memset(matches, 0, automata->words * sizeof(unsigned long));
+
+  for (size_t j = 0; sentence[j] != '\0'; j++) {
+    state = automata->table[state * TABLE_COLUMNS + (unsigned char)sentence[j]];
+    if (state == -1)
+      return 0; // No pattern can accept anymore
+  }
+
+  for (size_t w = 0; w < automata->words; w++) {
+    matches[w] = automata->accepts[state * automata->words + w];
+    for (unsigned long bits = matches[w]; bits != 0; bits &= bits - 1)
+      total++;
+  }
+
+  return total;
+}
+
+void free_union(union_af_t *automata) {
+  free_af(automata->dfa);
+  free(automata->accepts);
+  free(automata->table);
+  automata->dfa = NULL;
+  automata->accepts = NULL;
+  automata->table = NULL;
+}
@@ -0,0 +1,293 @@
+/*
+ ============================================================================
+ Name        : automata_utf8.c
+ Author      : Eduardo Lopes
+ Version     :
+ Copyright   : MIT license
+ Description : FTC task
+ ============================================================================
+ */
+
+#include <limits.h>
+
+#include "../include/automata_utf8.h"
+
+static size_t hash_node(short parent, unsigned char low, unsigned char high,
+                        size_t capacity) {
+  size_t hash = (size_t)(unsigned short)parent * 2654435761UL;
+
+  hash ^= ((size_t)low << 8 | high) * 40503UL;
+  return hash & (capacity - 1);
+}
+
+static label_node_t *find_node(label_trie_t *trie, short parent,
+                               unsigned char low, unsigned char high) {
+  size_t i = hash_node(parent, low, high, trie->capacity);
+
+  while (trie->nodes[i].state != -1 &&
+         (trie->nodes[i].parent != parent || trie->nodes[i].low != low ||
+          trie->nodes[i].high != high))
+    i = (i + 1) & (trie->capacity - 1);
+
+  return &trie->nodes[i];
+}
+
+static void grow_trie(label_trie_t *trie) {
+  label_node_t *old = trie->nodes;
+  size_t old_capacity = trie->capacity;
+
+  trie->capacity *= 2;
+  trie->nodes = (label_node_t *)calloc(trie->capacity, sizeof(label_node_t));
+  for (size_t i = 0; i < trie->capacity; i++)
+    trie->nodes[i].state = -1;
+
+  for (size_t i = 0; i < old_capacity; i++) {
+    if (old[i].state != -1)
+      *find_node(trie, old[i].parent, old[i].low, old[i].high) = old[i];
+  }
+
+  free(old);
+}
+
+/*
+ * Append one transition for each byte of range
+ */
+static void add_byte_range(af_t *automata, short from, short to,
+                           unsigned char low, unsigned char high) {
+  for (unsigned int byte = low; byte <= high; byte++)
+    append_transition(automata, from, to, (char)byte);
+}
+
+/*
+ * Read a sequence of byte ranges from a state to another. The prefix
+ * reuses the intermediate states of the trie
+ */
+static void add_sequence(af_t *automata, label_trie_t *trie, short from,
+                         short to, unsigned char *low, unsigned char *high,
+                         size_t length) {
+  short state = from;
+
+  for (size_t k = 0; k + 1 < length; k++) {
+    label_node_t *node = find_node(trie, state, low[k], high[k]);
+
+    if (node->state == -1) {
+      if (trie->next_state == SHRT_MAX) {
+        puts("Too many states to read the labels");
+        return;
+      }
+
+      node->parent = state;
+      node->low = low[k];
+      node->high = high[k];
+      node->state = trie->next_state++;
+      add_byte_range(automata, state, node->state, low[k], high[k]);
+
+      if (++trie->size * 2 > trie->capacity)
+        grow_trie(trie);
+      node = find_node(trie, state, low[k], high[k]);
+    }
+    state = node->state;
+  }
+
+  add_byte_range(automata, state, to, low[length - 1], high[length - 1]);
+}
+
+/*
+ * Split a code point range until each part have the same UTF-8 length
+ * and can be read by a sequence of byte ranges
+ */
+static void add_code_point_range(af_t *automata, label_trie_t *trie,
+                                 short from, short to, unsigned long low,
+                                 unsigned long high) {
+  static const unsigned long max_length[] = {0x7F, 0x7FF, 0xFFFF};
+  unsigned char low_bytes[4], high_bytes[4];
+
+  if (low > high)
+    return;
+
+  // Surrogates aren't valid on UTF-8
+  if (low <= 0xDFFF && high >= 0xD800) {
+    if (low < 0xD800)
+      add_code_point_range(automata, trie, from, to, low, 0xD7FF);
+    if (high > 0xDFFF)
+      add_code_point_range(automata, trie, from, to, 0xE000, high);
+    return;
+  }
+
+  for (size_t i = 0; i < 3; i++) {
+    if (low <= max_length[i] && high > max_length[i]) {
+      add_code_point_range(automata, trie, from, to, low, max_length[i]);
+      add_code_point_range(automata, trie, from, to, max_length[i] + 1, high);
+      return;
+    }
+  }
+
+  for (size_t i = 1; i < 4 && high > 0x7F; i++) {
+    unsigned long mask = (1UL << (6 * i)) - 1;
+
+    if ((low & ~mask) != (high & ~mask)) {
+      if ((low & mask) != 0) {
+        add_code_point_range(automata, trie, from, to, low, low | mask);
+        add_code_point_range(automata, trie, from, to, (low | mask) + 1, high);
+        return;
+      }
+      if ((high & mask) != mask) {
+        add_code_point_range(automata, trie, from, to, low, (high & ~mask) - 1);
+        add_code_point_range(automata, trie, from, to, high & ~mask, high);
+        return;
+      }
+    }
+  }
+
+  size_t length = utf8_encode(low, low_bytes);
+  utf8_encode(high, high_bytes);
+  add_sequence(automata, trie, from, to, low_bytes, high_bytes, length);
+}
+
+void init_label_trie(label_trie_t *trie, short first_state) {
+  trie->capacity = MAX_BUFFER_SIZE;
+  trie->size = 0;
+  trie->next_state = first_state;
+  trie->nodes = (label_node_t *)calloc(trie->capacity, sizeof(label_node_t));
+  for (size_t i = 0; i < trie->capacity; i++)
+    trie->nodes[i].state = -1;
+}
+
+void free_label_trie(label_trie_t *trie) {
+  free(trie->nodes);
+  trie->nodes = NULL;
+  trie->capacity = trie->size = 0;
+}
+
+char *decode_label(char *raw, size_t length) {
+  static const char *entities[][2] = {{"&lt;", "<"},
+                                      {"&gt;", ">"},
+                                      {"&amp;", "&"},
+                                      {"&quot;", "\""},
+                                      {"&apos;", "'"}};
+  char *label = (char *)calloc(length * 4 + 1, sizeof(char));
+  size_t size = 0;
+
+  for (size_t i = 0; i < length;) {
+    size_t j, n;
+    unsigned long code_point;
+    char *end;
+
+    if (raw[i] != '&') {
+      label[size++] = raw[i++];
+      continue;
+    }
+
+    for (j = 0; j < 5; j++) {
+      n = strlen(entities[j][0]);
+      if (i + n <= length && !strncmp(&raw[i], entities[j][0], n)) {
+        label[size++] = entities[j][1][0];
+        i += n;
+        break;
+      }
+    }
+    if (j < 5)
+      continue;
+
+    // Numeric reference, &#233; or &#xE9;
+    if (i + 2 < length && raw[i + 1] == '#') {
+      if (raw[i + 2] == 'x' || raw[i + 2] == 'X')
+        code_point = strtoul(&raw[i + 3], &end, 16);
+      else
+        code_point = strtoul(&raw[i + 2], &end, 10);
+
+      if ((size_t)(end - raw) < length && *end == ';' && code_point > 0 &&
+          code_point <= MAX_CODE_POINT) {
+        size += utf8_encode(code_point, (unsigned char *)&label[size]);
+        i = end - raw + 1;
+        continue;
+      }
+    }
+
+    label[size++] = raw[i++];
+  }
+
+  label[size] = '\0';
+  return label;
+}
+
+size_t utf8_decode(char *bytes, unsigned long *code_point) {
+  static const unsigned long min_value[] = {0, 0, 0x80, 0x800, 0x10000};
+  unsigned char *s = (unsigned char *)bytes;
+  size_t length;
+
+  if (s[0] < 0x80) {
+    *code_point = s[0];
+    return s[0] != 0;
+  } else if ((s[0] & 0xE0) == 0xC0) {
+    length = 2;
+    *code_point = s[0] & 0x1F;
+  } else if ((s[0] & 0xF0) == 0xE0) {
+    length = 3;
+    *code_point = s[0] & 0x0F;
+  } else if ((s[0] & 0xF8) == 0xF0) {
+    length = 4;
+    *code_point = s[0] & 0x07;
+  } else {
+    return 0;
+  }
+
+  for (size_t i = 1; i < length; i++) {
+    if ((s[i] & 0xC0) != 0x80)
+      return 0;
+    *code_point = *code_point << 6 | (s[i] & 0x3F);
+  }
+
+  // Overlong sequences, surrogates and values out of Unicode are invalid
+  if (*code_point < min_value[length] || *code_point > MAX_CODE_POINT ||
+      (*code_point >= 0xD800 && *code_point <= 0xDFFF))
+    return 0;
+
+  return length;
+}
+
+size_t utf8_encode(unsigned long code_point, unsigned char *bytes) {
+  if (code_point < 0x80) {
+    bytes[0] = code_point;
+    return 1;
+  } else if (code_point < 0x800) {
+    bytes[0] = 0xC0 | code_point >> 6;
+    bytes[1] = 0x80 | (code_point & 0x3F);
+    return 2;
+  } else if (code_point < 0x10000) {
+    bytes[0] = 0xE0 | code_point >> 12;
+    bytes[1] = 0x80 | (code_point >> 6 & 0x3F);
+    bytes[2] = 0x80 | (code_point & 0x3F);
+    return 3;
+  }
+
+  bytes[0] = 0xF0 | code_point >> 18;
+  bytes[1] = 0x80 | (code_point >> 12 & 0x3F);
+  bytes[2] = 0x80 | (code_point >> 6 & 0x3F);
+  bytes[3] = 0x80 | (code_point & 0x3F);
+  return 4;
+}
+
+void lower_label(af_t *automata, label_trie_t *trie, short from, short to,
+                 char *label) {
+  size_t length = strlen(label), first, last;
+  unsigned long low, high;
+
+  if (length == 0)
+    return;
+
+  // Code point range, like [a-z] or [α-ω]
+  if (length > 4 && label[0] == '[' && label[length - 1] == ']' &&
+      (first = utf8_decode(&label[1], &low)) != 0 && label[1 + first] == '-' &&
+      (last = utf8_decode(&label[2 + first], &high)) != 0 &&
+      3 + first + last == length) {
+    if (low > high)
+      puts("Invalid code point range, ignored");
+    add_code_point_range(automata, trie, from, to, low, high);
+    return;
+  }
+
+  // String, each byte is a transition
+  add_sequence(automata, trie, from, to, (unsigned char *)label,
+               (unsigned char *)label, length);
+}
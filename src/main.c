@@ -8,14 +8,125 @@
  ============================================================================
  */
 
+#include "../include/automata_batch.h"
+#include "../include/automata_cache.h"
 #include "../include/automata_convert.h"
+#include "../include/automata_renumber.h"
+#include "../include/automata_table.h"
+#include "../include/automata_trim.h"
+#include "../include/automata_union.h"
 
 int main(int argc, char *argv[]) {
-  if (argc <= 1) {
+  char *profile_file = NULL, *table_file = NULL, *cache_dir = NULL;
+  char *sentences_file = NULL, *load_file = NULL;
+  char **files = (char **)calloc(argc, sizeof(char *));
+  size_t num_files = 0;
+  short bfs_order = 0, trim = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (argv[i][0] != '-') {
+      files[num_files++] = argv[i];
+    } else if (!strcmp(argv[i], "-t")) {
+      trim = 1;
+    } else if (!strcmp(argv[i], "-b")) {
+      bfs_order = 1;
+    } else if (!strcmp(argv[i], "-p") && i + 1 < argc) {
+      profile_file = argv[++i];
+    } else if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+      cache_dir = argv[++i];
+    } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+      sentences_file = argv[++i];
+    } else if (!strcmp(argv[i], "-z") && i + 1 < argc) {
+      table_file = argv[++i];
+    } else if (!strcmp(argv[i], "-l") && i + 1 < argc) {
+      load_file = argv[++i];
+    } else {
+      num_files = 0;
+      break;
+    }
+  }
+
+  /*
+   * A saved table is simulated alone, without any JFLAP file
+   */
+  if (load_file != NULL && argc == 3) {
+    comb_table_t table;
+    char *buffer = "01";
+
+    free(files);
+    if (!read_comb_table(&table, load_file))
+      return EXIT_FAILURE;
+
+    fprintf(stdout, "Compressed table: %lu slots for %lu states\n", table.size,
+            table.num_states);
+    if (simulate_comb_table(&table, buffer)) {
+      puts("Sentença aceita!");
+    } else {
+      puts("Sentença não aceita!");
+    }
+
+    free_comb_table(&table);
+    return EXIT_SUCCESS;
+  }
+
+  /*
+   * The options change the single automata, the union has none of them
+   */
+  short options = trim || bfs_order || profile_file != NULL ||
+                  cache_dir != NULL || sentences_file != NULL ||
+                  table_file != NULL;
+
+  if (num_files == 0 || load_file != NULL || (num_files > 1 && options)) {
     help(argv[0]);
+    free(files);
     return EXIT_FAILURE;
   }
 
+  /*
+   * Sentence to simulate
+   */
+  char *buffer = "01";
+
+  /*
+   * With more than one file, all patterns are tested with one pass
+   */
+  if (num_files > 1) {
+    af_t **patterns = (af_t **)calloc(num_files, sizeof(af_t *));
+    union_af_t automata;
+
+    for (size_t i = 0; i < num_files; i++) {
+      patterns[i] = (af_t *)malloc(sizeof(af_t));
+      init_automata(patterns[i]);
+      automata_file_parser(files[i], patterns[i]);
+    }
+
+    union_convert(patterns, num_files, &automata);
+    show_automata(automata.dfa);
+
+    unsigned long *matches =
+        (unsigned long *)calloc(automata.words, sizeof(unsigned long));
+
+    if (simulate_union(&automata, buffer, matches)) {
+      for (size_t i = 0; i < num_files; i++) {
+        if (matches[i / SET_WORD_BITS] >> (i % SET_WORD_BITS) & 1UL)
+          fprintf(stdout, "Sentença aceita por %s\n", files[i]);
+      }
+    } else {
+      puts("Sentença não aceita!");
+    }
+
+    create_automata_file(automata.dfa, "test/afd.jff");
+
+    for (size_t i = 0; i < num_files; i++)
+      free_af(patterns[i]);
+    free(patterns);
+    free(matches);
+    free_union(&automata);
+    free(files);
+
+    return EXIT_SUCCESS;
+  }
+
   af_t *non_det = (af_t *)malloc(sizeof(af_t));
   init_automata(non_det);
 
@@ -23,31 +134,109 @@ int main(int argc, char *argv[]) {
    * Read the .xml files to receive the AFN, and put it
    * on the struct
    */
-  automata_file_parser(argv[1], non_det);
+  automata_file_parser(files[0], non_det);
 
   /*
    * Call the function to parse the AFN and return AFD
    */
   af_t *det = (af_t *)malloc(sizeof(af_t));
+  short cached = 0;
   init_automata(det);
-  deterministic_convert(non_det, det);
+
+  if (cache_dir != NULL) {
+    af_cache_t cache = {cache_dir, CACHE_MAX_SIZE};
+    unsigned char key[CACHE_KEY_SIZE];
+
+    cache_key(non_det, "deterministic_convert", key);
+    cached = cache_load(&cache, key, det);
+
+    if (!cached) {
+      deterministic_convert(non_det, det);
+      cache_store(&cache, key, det);
+    }
+  } else {
+    deterministic_convert(non_det, det);
+  }
+
+  /*
+   * Remove useless states, and send missing transitions to a dead state
+   */
+  if (trim)
+    trim_automata(det);
+
+  /*
+   * Give the hot states the lowest ids, so their transitions are
+   * packed together on the table
+   */
+  if (profile_file != NULL) {
+    size_t count;
+    char **sentences = read_sentences(profile_file, &count);
+    size_t *visits = (size_t *)calloc(count_states(det), sizeof(size_t));
+
+    for (size_t i = 0; i < count; i++)
+      profile_automata(det, sentences[i], visits);
+    renumber_states(det, visits);
+
+    free(visits);
+    free_sentences(sentences, count);
+  } else if (bfs_order) {
+    renumber_states(det, NULL);
+  }
   show_automata(det);
 
   /*
    * Call function to simulate AFD
    */
-  char *buffer = "01";
+  short accepted;
+
+  if (table_file != NULL) {
+    comb_table_t table;
+
+    build_comb_table(det, &table);
+    fprintf(stdout, "Compressed table: %lu slots for %lu states\n", table.size,
+            table.num_states);
+    accepted = simulate_comb_table(&table, buffer);
+    write_comb_table(&table, table_file);
+    free_comb_table(&table);
+  } else {
+    accepted = simulate_automata(det, buffer);
+  }
 
-  if (simulate_automata(det, buffer)) {
+  if (accepted) {
     puts("Sentença aceita!");
   } else {
     puts("Sentença não aceita!");
   }
 
+  /*
+   * Test all sentences of file, sharing the common prefixes
+   */
+  if (sentences_file != NULL) {
+    size_t count, length = 0;
+    char **sentences = read_sentences(sentences_file, &count);
+    short *results = (short *)calloc(count + 1, sizeof(short));
+    size_t steps = simulate_batch(det, sentences, count, results);
+
+    for (size_t i = 0; i < count; i++) {
+      fprintf(stdout, "%s: %s\n", sentences[i],
+              results[i] ? "aceita" : "não aceita");
+      length += strlen(sentences[i]);
+    }
+    fprintf(stdout, "Transitions walked: %lu of %lu\n", steps, length);
+
+    free(results);
+    free_sentences(sentences, count);
+  }
+
   create_automata_file(det, "test/afd.jff");
 
-  free(non_det);
+  // Without cache, both automata share the same arrays
+  if (cached)
+    free_af(non_det);
+  else
+    free(non_det);
   free_af(det);
+  free(files);
 
   return EXIT_SUCCESS;
 }